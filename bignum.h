@@ -9,11 +9,15 @@
 #include <string.h>
 #include "tests/list.h"
 
-#define vzalloc(s) calloc(s, 1)
 #define kmalloc(s, gfp) malloc(s)
 #define kfree(p) free(p)
-#define vfree(p) free(p)
 #define printk(...) printf(__VA_ARGS__)
+#define swap(a, b)             \
+    do {                       \
+        typeof(a) __tmp = (a); \
+        (a) = (b);             \
+        (b) = __tmp;           \
+    } while (0)
 #define U64_FMT "lu"
 #else
 #include <linux/list.h>
@@ -144,6 +148,10 @@ static inline void bignum_add_to_smaller(struct list_head *lgr,
                                          struct list_head *slr);
 static inline void bignum_sub_from_larger(struct list_head *lgr,
                                           struct list_head *slr);
+static inline struct list_head *bignum_dup(struct list_head *src);
+static inline struct list_head *bignum_add(struct list_head *a,
+                                           struct list_head *b);
+static inline void bignum_trim(struct list_head *head);
 
 static inline struct list_head *bignum_multiply(struct list_head *mtr,
                                                 struct list_head *mtd);
@@ -160,8 +168,8 @@ static inline struct list_head *bignum_new(uint64_t val)
     head->len = 0;  // must before NEW_BIGNUM_NODE
     INIT_LIST_HEAD(&head->link);
     NEW_BIGNUM_NODE(&head->link, val % BOUND64);
-    if (val >= BOUND64)
-        NEW_BIGNUM_NODE(&head->link, val / BOUND64);
+    for (val /= BOUND64; val; val /= BOUND64)
+        NEW_BIGNUM_NODE(&head->link, val % BOUND64);
     return &head->link;
 }
 
@@ -215,13 +223,52 @@ static inline void bignum_sub_from_larger(struct list_head *lgr,
 
         // delete redundant 0 node
         list_del(&ptr->link);
-        vfree(ptr);
+        kfree(ptr);
 
         // dont forget change length
         list_entry(lgr, bignum_head, link)->len--;
     }
 }
 
+static inline struct list_head *bignum_dup(struct list_head *src)
+{
+    bignum_head *head = kmalloc(sizeof(bignum_head), GFP_KERNEL);
+    head->len = 0;  // must before NEW_BIGNUM_NODE
+    INIT_LIST_HEAD(&head->link);
+
+    bignum_node *src_node;
+    list_for_each_entry (src_node, src, link)
+        NEW_BIGNUM_NODE(&head->link, src_node->value);
+    return &head->link;
+}
+
+static inline struct list_head *bignum_add(struct list_head *a,
+                                           struct list_head *b)
+{
+    // bignum_add_to_smaller needs lgr to have at least as many nodes as slr
+    if (list_entry(a, bignum_head, link)->len <
+        list_entry(b, bignum_head, link)->len)
+        swap(a, b);
+
+    struct list_head *sum = bignum_dup(b);
+    bignum_add_to_smaller(a, sum);
+    return sum;
+}
+
+static inline void bignum_trim(struct list_head *head)
+{
+    // remove leading zeros, but always keep the least significant node
+    while (head->prev != head->next) {
+        bignum_node *node = list_entry(head->prev, bignum_node, link);
+        if (node->value)
+            break;
+
+        list_del(&node->link);
+        kfree(node);
+        list_entry(head, bignum_head, link)->len--;
+    }
+}
+
 static inline struct list_head *bignum_multiply(struct list_head *mtr,
                                                 struct list_head *mtd)
 {
@@ -257,6 +304,8 @@ static inline struct list_head *bignum_multiply(struct list_head *mtr,
         }
     }
 
+    // zero nodes of mtr or mtd may leave leading zeros
+    bignum_trim(result);
     return result;
 }
 
@@ -292,30 +341,28 @@ static inline char *bignum_to_string(struct list_head *head)
     // UINT64 < BOUND64 (10^18)
     size_t digits = list_entry(head, bignum_head, link)->len * MAX_DIGITS + 1;
 
-    // DMA for result string
-    char *res = vzalloc(digits);
-
-    if (!res)
+    // decode from Most Significant Node
+    if (head == head->next)
         return NULL;
 
-    // decode from Most Significant Node
-    if (head == head->next) {
-        vfree(res);
+    // small enough for kmalloc, vzalloc would take whole pages
+    char *res = kmalloc(digits, GFP_KERNEL);
+
+    if (!res)
         return NULL;
-    }
 
     uint64_t node_result = 0;
     struct list_head *p = head->prev;
 
     // Most Significant Node
     node_result = list_entry(p, bignum_node, link)->value;
-    snprintf(res, MAX_DIGITS + 1, "%" U64_FMT, node_result);
+    size_t pos = snprintf(res, MAX_DIGITS + 1, "%" U64_FMT, node_result);
 
     // other nodes
     for (p = p->prev; p != head; p = p->prev) {
-        size_t pos = strlen(res);
         node_result = list_entry(p, bignum_node, link)->value;
-        snprintf(&res[pos], MAX_DIGITS + 1, LEADING_FMT U64_FMT, node_result);
+        pos += snprintf(&res[pos], MAX_DIGITS + 1, LEADING_FMT U64_FMT,
+                        node_result);
     }
 
     return res;
@@ -5,8 +5,116 @@
 #include <sys/types.h>
 #include <unistd.h>
 
+#include "fibdrv.h"
+
 #define FIB_DEV "/dev/fibonacci"
 
+static void set_mode(int fd, enum FIB_MODES mode)
+{
+    char buf[4];
+    snprintf(buf, sizeof(buf), "%d", mode);
+    if (write(fd, buf, strlen(buf)) < 0)
+        printf("Failed to set mode %d.\n", mode);
+}
+
+/* read at offset n and print it tagged with mode and its parameters */
+static void check_at(int fd, const char *tag, long long n)
+{
+    char result[128] = {0};
+    lseek(fd, n, SEEK_SET);
+    if (read(fd, result, sizeof(result) - 1) < 0)
+        snprintf(result, sizeof(result), "error");
+    printf("Checking %s at offset %lld, returned the sequence %s.\n", tag, n,
+           result);
+}
+
+static const long long large_offsets[] = {
+    0, 1, 2, 93, 100, 1000000, 1000000000000000000LL, 9223372036854775807LL,
+};
+#define LARGE_OFFSETS (sizeof(large_offsets) / sizeof(large_offsets[0]))
+
+static void check_mod_64(int fd)
+{
+    const uint64_t moduli[] = {1000000007ULL, 18446744073709551557ULL};
+
+    set_mode(fd, FIB_MODE_MOD_64);
+    for (size_t i = 0; i < sizeof(moduli) / sizeof(moduli[0]); i++) {
+        char tag[32];
+        snprintf(tag, sizeof(tag), "mod=%llu", (unsigned long long) moduli[i]);
+        if (ioctl(fd, FIB_IOC_SET_MODULUS, &moduli[i]) < 0)
+            printf("Failed to set modulus %s.\n", tag);
+        for (size_t j = 0; j < LARGE_OFFSETS; j++)
+            check_at(fd, tag, large_offsets[j]);
+    }
+}
+
+static const long long small_offsets[] = {0, 1, 2, 3, 50, 99, 100};
+#define SMALL_OFFSETS (sizeof(small_offsets) / sizeof(small_offsets[0]))
+
+/* names must match the recurrences in scripts/verify.py */
+static const struct {
+    const char *name;
+    struct fib_recurrence rec;
+    int wraps; /* only meaningful modulo 2^64, skipped by FIB_MODE_REC_BIG */
+} recurrences[] = {
+    {"lucas", {2, {1, 1}, {2, 1}}},
+    {"pell", {2, {2, 1}, {0, 1}}},
+    {"tribonacci", {3, {1, 1, 1}, {0, 0, 1}}},
+    {"padovan", {3, {0, 1, 1}, {1, 1, 1}}},
+    {"period6", {2, {1, -1ULL}, {0, 1}}, 1},
+};
+
+static void check_recurrences(int fd,
+                              enum FIB_MODES mode,
+                              const char *prefix,
+                              const long long *offsets,
+                              size_t count)
+{
+    set_mode(fd, mode);
+    for (size_t i = 0; i < sizeof(recurrences) / sizeof(recurrences[0]); i++) {
+        char tag[32];
+        if (mode == FIB_MODE_REC_BIG && recurrences[i].wraps)
+            continue;
+        snprintf(tag, sizeof(tag), "%s=%s", prefix, recurrences[i].name);
+        if (ioctl(fd, FIB_IOC_SET_RECURRENCE, &recurrences[i].rec) < 0)
+            printf("Failed to set recurrence %s.\n", tag);
+        for (size_t j = 0; j < count; j++)
+            check_at(fd, tag, offsets[j]);
+    }
+}
+
+/* the table covers n <= 93, beyond that both wrap modulo 2^64 */
+static void check_table_64(int fd, int limit)
+{
+    set_mode(fd, FIB_MODE_TABLE_64);
+    for (int i = 0; i <= limit; i++)
+        check_at(fd, "table", i);
+    set_mode(fd, FIB_MODE_BASIC_64);
+    for (int i = 0; i <= limit; i++)
+        check_at(fd, "basic64", i);
+}
+
+static const long long leading_offsets[] = {
+    0, 1, 2, 12, 93, 94, 100, 1000, 1001, 384339, 1038753276079106978LL,
+    9223372036854775807LL,
+};
+#define LEADING_OFFSETS (sizeof(leading_offsets) / sizeof(leading_offsets[0]))
+
+static void check_leading(int fd)
+{
+    const uint64_t digits[] = {1, 5, FIB_LEAD_MAX_DIGITS};
+
+    set_mode(fd, FIB_MODE_LEADING);
+    for (size_t i = 0; i < sizeof(digits) / sizeof(digits[0]); i++) {
+        char tag[32];
+        snprintf(tag, sizeof(tag), "lead=%llu", (unsigned long long) digits[i]);
+        if (ioctl(fd, FIB_IOC_SET_DIGITS, &digits[i]) < 0)
+            printf("Failed to set digits %s.\n", tag);
+        for (size_t j = 0; j < LEADING_OFFSETS; j++)
+            check_at(fd, tag, leading_offsets[j]);
+    }
+}
+
 int main(int argc, char *argv[])
 {
     long long sz;
@@ -41,6 +149,14 @@ int main(int argc, char *argv[])
                FIB_DEV, i, result);
     }
 
+    check_mod_64(fd);
+    check_recurrences(fd, FIB_MODE_REC_64, "rec64", large_offsets,
+                      LARGE_OFFSETS);
+    check_recurrences(fd, FIB_MODE_REC_BIG, "recbig", small_offsets,
+                      SMALL_OFFSETS);
+    check_table_64(fd, offset);
+    check_leading(fd);
+
     free(result);
     close(fd);
     return 0;
@@ -4,12 +4,14 @@
 #include <linux/init.h>
 #include <linux/kdev_t.h>
 #include <linux/kernel.h>
+#include <linux/math64.h>
 #include <linux/mm.h>
 #include <linux/module.h>
+#include <linux/overflow.h>
 #include <linux/slab.h>
-#include <linux/vmalloc.h>
 
 #include "bignum.h"
+#include "fibdrv.h"
 
 MODULE_LICENSE("Dual MIT/GPL");
 MODULE_AUTHOR("National Cheng Kung University, Taiwan");
@@ -18,24 +20,133 @@ MODULE_VERSION("0.1");
 
 #define DEV_FIBONACCI_NAME "fibonacci"
 
-#define ULL_TO_USER_BUF(val, buf, size)                                 \
-    ({                                                                  \
-        char *tmp = vmalloc(21);                                        \
-        snprintf(tmp, 21, "%lu", val);                                  \
-        size_t failed = copy_to_user(buf, tmp, min(size, (size_t) 21)); \
-        vfree(tmp);                                                     \
-        failed;                                                         \
+// 20 digits of UINT64_MAX and '\0' always fit on stack
+#define ULL_TO_USER_BUF(val, buf, size)                                     \
+    ({                                                                      \
+        char tmp[21];                                                       \
+        size_t len =                                                        \
+            snprintf(tmp, sizeof(tmp), "%llu", (unsigned long long) (val)); \
+        copy_to_user(buf, tmp, min(size, len + 1));                         \
     })
 
 // Set MAX_LENGTH to 92 to prevent uint64 overflow
 #define MAX_LENGTH 100
 
-static enum FIB_MODES {
-    FIB_MODE_BASIC_64 = 0,
-    FIB_MODE_BASIC_BIG = 1,
-    FIB_MODE_FAST_DOUBLING_64 = 2,
-    FIB_MODE_FAST_DOUBLING_BIG = -1,
-} mode = FIB_MODE_BASIC_64;
+// F(93) is the largest fibonacci number fits in uint64
+#define FIB_TABLE_SIZE 94
+
+static enum FIB_MODES mode = FIB_MODE_BASIC_64;
+
+// F(0) ... F(93), filled when module is loaded
+static uint64_t fib_table[FIB_TABLE_SIZE];
+
+// modulus for FIB_MODE_MOD_64, 0 means not set yet
+static uint64_t fib_modulus = 0;
+
+// recurrence for FIB_MODE_REC_64 and FIB_MODE_REC_BIG, fibonacci by default
+static struct fib_recurrence fib_rec = {
+    .order = 2,
+    .coef = {1, 1},
+    .init = {0, 1},
+};
+
+// number of leading digits reported by FIB_MODE_LEADING
+static uint64_t fib_lead_digits = 10;
+
+// constants below are printed by scripts/lead_consts.py
+// log10(phi) in 0.192 and log10(sqrt(5)) in 0.128 fixed point, high first
+static const uint64_t log10_phi[3] = {
+    0x358036c82451b7f3ULL, 0x65d3db23845599f5ULL, 0x887a5e47e9bdd71cULL};
+static const uint64_t log10_sqrt5[2] = {0x5977d95ec10c0219ULL,
+                                        0xdc1da994fd20dba1ULL};
+
+// ln(10) in 2.62 fixed point
+#define LN10_FIXED 0x935d8dddaaa8ac17ULL
+
+// 10^(2^-(i + 1)) in 4.124 fixed point, {high, low} 64 bits
+static const uint64_t exp10_frac[62][2] = {
+    {0x3298b075b4b6a524ULL, 0x0945790619b37fd5ULL},
+    {0x1c73d51c54470e30ULL, 0xfe6f9311d01e8369ULL},
+    {0x15561a91ba81443dULL, 0xdc7327cc4b3307c8ULL},
+    {0x1279fcaca404e5acULL, 0xcb5499f25b6d94e8ULL},
+    {0x113197fa6aa6776bULL, 0x27893c62914607a3ULL},
+    {0x10960c68d98bc2bfULL, 0x2e022919eabc4226ULL},
+    {0x104a5975b254b8aeULL, 0x4077c2f56458fcfcULL},
+    {0x102501ee61ca6267ULL, 0x1e4fa4f8abdf212dULL},
+    {0x101276506106747aULL, 0xa3b1aab6aeb4b50eULL},
+    {0x1009388004be7e55ULL, 0x92e3f8d6c82736b3ULL},
+    {0x10049b96285bc0a7ULL, 0x363c07b134055792ULL},
+    {0x10024da0a3c92c8cULL, 0xc11499f5931deaf2ULL},
+    {0x100126c5b68ed631ULL, 0xf08c1fff9b1f311dULL},
+    {0x10009360348a6725ULL, 0xcfeba1059a0b4ce0ULL},
+    {0x100049af7098ffffULL, 0xc25510fadf1d9042ULL},
+    {0x100024d78de1d4c6ULL, 0xc2bbc6a8ef5d916dULL},
+    {0x1000126bbc564bcaULL, 0x768860bf564eeda3ULL},
+    {0x10000935db847fc5ULL, 0xaa9e081feeda3071ULL},
+    {0x1000049aed18968bULL, 0xc64ec84c8fb8e09eULL},
+    {0x1000024d7661e0f6ULL, 0x3a0af573a6217720ULL},
+    {0x10000126bb2655e7ULL, 0xf612ba7c416be3a3ULL},
+    {0x100000935d90844fULL, 0x49b73713144cacdcULL},
+    {0x10000049aec7987eULL, 0x7b946322b95fc265ULL},
+    {0x10000024d763a1d4ULL, 0xf3da0d9a9d3dfa66ULL},
+    {0x100000126bb1c64fULL, 0xe77d3313e4c1d005ULL},
+    {0x1000000935d8e081ULL, 0x4f242b441f1ffb96ULL},
+    {0x100000049aec6f96ULL, 0xfe6baae5ab8df5e1ULL},
+    {0x100000024d7637a1ULL, 0x14ec40de5edeb5d1ULL},
+    {0x1000000126bb1bc5ULL, 0xefe3bc0d65f838a4ULL},
+    {0x10000000935d8de0ULL, 0x514d4506ab26b017ULL},
+    {0x1000000049aec6efULL, 0x7efd7c4660ef086fULL},
+    {0x1000000024d76377ULL, 0x9514749454f891bdULL},
+    {0x10000000126bb1bbULL, 0xbfefa7e67fd1d06eULL},
+    {0x100000000935d8ddULL, 0xdd512f5a56c4f2a0ULL},
+    {0x10000000049aec6eULL, 0xedfeee86f14a50fbULL},
+    {0x10000000024d7637ULL, 0x76d50cf9ea25390aULL},
+    {0x100000000126bb1bULL, 0xbb5febea917363fdULL},
+    {0x1000000000935d8dULL, 0xddad4f50afd1fc47ULL},
+    {0x100000000049aec6ULL, 0xeed5fdff31af13c3ULL},
+    {0x100000000024d763ULL, 0x776ad4954f490fabULL},
+    {0x1000000000126bb1ULL, 0xbbb55fb01540e954ULL},
+    {0x10000000000935d8ULL, 0xdddaad3166078d0bULL},
+    {0x1000000000049aecULL, 0x6eed55ef09dd8c9eULL},
+    {0x1000000000024d76ULL, 0x3776aacd1aa537d5ULL},
+    {0x10000000000126bbULL, 0x1bbb555bf2c0384cULL},
+    {0x100000000000935dULL, 0x8dddaaab52bb833eULL},
+    {0x10000000000049aeULL, 0xc6eed554ffb49b65ULL},
+    {0x10000000000024d7ULL, 0x63776aaa55700424ULL},
+    {0x100000000000126bULL, 0xb1bbb555201d6faeULL},
+    {0x1000000000000935ULL, 0xd8dddaaa8d68133eULL},
+    {0x100000000000049aULL, 0xec6eed55460a6079ULL},
+    {0x100000000000024dULL, 0x763776aaa2dac5f3ULL},
+    {0x1000000000000126ULL, 0xbb1bbb555162c867ULL},
+    {0x1000000000000093ULL, 0x5d8dddaaa8aebd8fULL},
+    {0x1000000000000049ULL, 0xaec6eed55456b51eULL},
+    {0x1000000000000024ULL, 0xd763776aaa2b3025ULL},
+    {0x1000000000000012ULL, 0x6bb1bbb555158d78ULL},
+    {0x1000000000000009ULL, 0x35d8dddaaa8ac415ULL},
+    {0x1000000000000004ULL, 0x9aec6eed55456161ULL},
+    {0x1000000000000002ULL, 0x4d763776aaa2b086ULL},
+    {0x1000000000000001ULL, 0x26bb1bbb55515838ULL},
+    {0x1000000000000000ULL, 0x935d8dddaaa8ac1aULL},
+};
+
+/*
+ * Bound of the mantissa error in units of 2^-124. The 63 truncated products
+ * and 62 rounded table entries are each off by at most one unit, scaled by
+ * at most 10 through later factors. The 10^g tail and the log10 constants
+ * add under 100 units more, so 2^11 units suffice and 2^14 leaves margin.
+ */
+#define LEAD_ERROR (1ULL << 14)
+
+typedef uint64_t rec_mat_64[FIB_REC_MAX_ORDER][FIB_REC_MAX_ORDER];
+typedef struct list_head *rec_mat_big[FIB_REC_MAX_ORDER][FIB_REC_MAX_ORDER];
+
+// matrices for companion matrix power, too large for kernel stack
+struct rec_mats_64 {
+    rec_mat_64 res, comp, tmp;
+};
+struct rec_mats_big {
+    rec_mat_big res, comp, tmp;
+};
 
 static dev_t fib_dev = 0;
 static struct cdev *fib_cdev;
@@ -91,6 +202,395 @@ static ssize_t fib_fast_64(uint64_t target, char *buf, size_t size)
     return (ssize_t) ktime_to_ns(kt);
 }
 
+static ssize_t fib_table_64(uint64_t target, char *buf, size_t size)
+{
+    // overflowed results are left to fast doubling, same as other 64 modes
+    if (target >= FIB_TABLE_SIZE)
+        return fib_fast_64(target, buf, size);
+
+    uint64_t ks = ktime_get();  // measure start
+    uint64_t result = fib_table[target];
+    uint64_t kt = ktime_sub(ktime_get(), ks);  // measure finish
+
+#ifndef CALC_ONLY
+    // copy result to buffer
+    if (ULL_TO_USER_BUF(result, buf, size))
+        pr_warn("%s:%d: Cannot copy all content.\n", __func__, __LINE__);
+#endif
+
+    return (ssize_t) ktime_to_ns(kt);
+}
+
+/* (a + b) % m, both operands must be already reduced */
+static inline uint64_t addmod_64(uint64_t a, uint64_t b, uint64_t m)
+{
+    uint64_t sum = a + b;
+    uint64_t mask = -(uint64_t) (sum < a || sum >= m);
+    return sum - (m & mask);
+}
+
+/* (a - b) % m, both operands must be already reduced */
+static inline uint64_t submod_64(uint64_t a, uint64_t b, uint64_t m)
+{
+    uint64_t mask = -(uint64_t) (a < b);
+    return a - b + (m & mask);
+}
+
+/* (a * b) % m, both operands must be already reduced */
+static inline uint64_t mulmod_64(uint64_t a, uint64_t b, uint64_t m)
+{
+#if defined(CONFIG_X86_64)
+    // 128-bit product, hi < m so the quotient of divq always fits in 64 bits
+    uint64_t lo, hi;
+    asm("mulq %3" : "=a"(lo), "=d"(hi) : "a"(a), "rm"(b));
+    asm("divq %2" : "+a"(lo), "+d"(hi) : "rm"(m));
+    return hi;
+#else
+    // no 128-bit division in kernel, fallback to double-and-add
+    uint64_t res = 0;
+    for (; b; b >>= 1) {
+        res = addmod_64(res, a & -(b & 1), m);
+        a = addmod_64(a, a, m);
+    }
+    return res;
+#endif
+}
+
+static ssize_t fib_mod_64(uint64_t target, char *buf, size_t size)
+{
+    uint64_t ks = ktime_get();  // measure start
+    uint64_t m = fib_modulus, result = !!target % m;
+    if (target > 2) {
+        // find first 1
+        uint8_t count = 63 - __builtin_clzll(target);
+        uint64_t fib_n0 = 1 % m, fib_n1 = 1 % m;
+
+        for (uint64_t i = count, fib_2n0, fib_2n1, mask; i-- > 0;) {
+            fib_2n0 = mulmod_64(
+                fib_n0, submod_64(addmod_64(fib_n1, fib_n1, m), fib_n0, m), m);
+            fib_2n1 = addmod_64(mulmod_64(fib_n0, fib_n0, m),
+                                mulmod_64(fib_n1, fib_n1, m), m);
+
+            mask = -!!(target & (1ULL << i));
+            fib_n0 = (fib_2n0 & ~mask) + (fib_2n1 & mask);
+            fib_n1 = addmod_64(fib_2n0 & mask, fib_2n1, m);
+        }
+        result = fib_n0;
+    }
+    uint64_t kt = ktime_sub(ktime_get(), ks);  // measure finish
+
+#ifndef CALC_ONLY
+    // copy result to buffer
+    if (ULL_TO_USER_BUF(result, buf, size))
+        pr_warn("%s:%d: Cannot copy all content.\n", __func__, __LINE__);
+#endif
+
+    return (ssize_t) ktime_to_ns(kt);
+}
+
+/* a(n) of an order 2 recurrence by fast doubling of lucas sequence U(n) */
+static uint64_t rec_doubling_64(uint64_t target)
+{
+    uint64_t c1 = fib_rec.coef[0], c2 = fib_rec.coef[1], t = target - 1;
+    // find first 1
+    uint8_t count = 64 - __builtin_clzll(t);
+    uint64_t u_n0 = 0, u_n1 = 1;
+
+    for (uint64_t i = count, u_2n0, u_2n1, mask; i-- > 0;) {
+        u_2n0 = u_n0 * ((u_n1 << 1) - c1 * u_n0);
+        u_2n1 = u_n1 * u_n1 + c2 * u_n0 * u_n0;
+
+        mask = -!!(t & (1ULL << i));
+        u_n0 = (u_2n0 & ~mask) + (u_2n1 & mask);
+        u_n1 = ((c1 * u_2n1 + c2 * u_2n0) & mask) + (u_2n1 & ~mask);
+    }
+
+    // a(n) = a(1) * U(n) + c2 * a(0) * U(n - 1)
+    return fib_rec.init[1] * u_n1 + c2 * fib_rec.init[0] * u_n0;
+}
+
+/* dst = a * b, dst must not be a or b */
+static void rec_mat_mul_64(rec_mat_64 dst,
+                           rec_mat_64 a,
+                           rec_mat_64 b,
+                           size_t k)
+{
+    for (size_t i = 0; i < k; i++)
+        for (size_t j = 0; j < k; j++) {
+            uint64_t sum = 0;
+            for (size_t l = 0; l < k; l++)
+                sum += a[i][l] * b[l][j];
+            dst[i][j] = sum;
+        }
+}
+
+/* a(n) of an order k recurrence by power of its companion matrix */
+static int rec_matrix_64(uint64_t target, uint64_t *result)
+{
+    size_t k = fib_rec.order;
+    struct rec_mats_64 *m = kzalloc(sizeof(*m), GFP_KERNEL);
+    if (!m)
+        return -ENOMEM;
+
+    for (size_t i = 0; i < k; i++) {
+        m->res[i][i] = 1;
+        m->comp[0][i] = fib_rec.coef[i];
+        if (i)
+            m->comp[i][i - 1] = 1;
+    }
+
+    // res = comp ^ target, from the most significant bit
+    for (uint64_t i = 64 - __builtin_clzll(target); i-- > 0;) {
+        rec_mat_mul_64(m->tmp, m->res, m->res, k);
+        memcpy(m->res, m->tmp, sizeof(m->tmp));
+        if (target & (1ULL << i)) {
+            rec_mat_mul_64(m->tmp, m->res, m->comp, k);
+            memcpy(m->res, m->tmp, sizeof(m->tmp));
+        }
+    }
+
+    // (a(n + k - 1), ..., a(n)) = res * (a(k - 1), ..., a(0))
+    *result = 0;
+    for (size_t j = 0; j < k; j++)
+        *result += m->res[k - 1][j] * fib_rec.init[k - 1 - j];
+
+    kfree(m);
+    return 0;
+}
+
+static ssize_t fib_rec_64(uint64_t target, char *buf, size_t size)
+{
+    uint64_t ks = ktime_get();  // measure start
+    uint64_t result;
+    if (target < fib_rec.order)
+        result = fib_rec.init[target];
+    else if (fib_rec.order == 2)
+        result = rec_doubling_64(target);
+    else if (rec_matrix_64(target, &result))
+        return -ENOMEM;
+    uint64_t kt = ktime_sub(ktime_get(), ks);  // measure finish
+
+#ifndef CALC_ONLY
+    // copy result to buffer
+    if (ULL_TO_USER_BUF(result, buf, size))
+        pr_warn("%s:%d: Cannot copy all content.\n", __func__, __LINE__);
+#endif
+
+    return (ssize_t) ktime_to_ns(kt);
+}
+
+static void rec_mat_free_big(rec_mat_big mat, size_t k)
+{
+    for (size_t i = 0; i < k; i++)
+        for (size_t j = 0; j < k; j++)
+            bignum_free(mat[i][j]);
+}
+
+/* dst = a * b, dst must not be a or b */
+static void rec_mat_mul_big(rec_mat_big dst,
+                            rec_mat_big a,
+                            rec_mat_big b,
+                            size_t k)
+{
+    for (size_t i = 0; i < k; i++)
+        for (size_t j = 0; j < k; j++) {
+            struct list_head *sum = bignum_new(0);
+            for (size_t l = 0; l < k; l++) {
+                struct list_head *prod = bignum_multiply(a[i][l], b[l][j]),
+                                 *tmp = bignum_add(sum, prod);
+                bignum_free(prod);
+                bignum_free(sum);
+                sum = tmp;
+            }
+            dst[i][j] = sum;
+        }
+}
+
+static ssize_t fib_rec_big(uint64_t target, char *buf, size_t size)
+{
+    uint64_t ks = ktime_get();  // measure start
+    size_t k = fib_rec.order;
+    struct list_head *result;
+
+    if (target < k) {
+        result = bignum_new(fib_rec.init[target]);
+    } else {
+        struct rec_mats_big *m = kzalloc(sizeof(*m), GFP_KERNEL);
+        if (!m)
+            return -ENOMEM;
+
+        for (size_t i = 0; i < k; i++)
+            for (size_t j = 0; j < k; j++) {
+                m->res[i][j] = bignum_new(i == j);
+                m->comp[i][j] = bignum_new(i ? i - 1 == j : fib_rec.coef[j]);
+            }
+
+        // res = comp ^ target, from the most significant bit
+        for (uint64_t i = 64 - __builtin_clzll(target); i-- > 0;) {
+            rec_mat_mul_big(m->tmp, m->res, m->res, k);
+            rec_mat_free_big(m->res, k);
+            memcpy(m->res, m->tmp, sizeof(m->tmp));
+            if (target & (1ULL << i)) {
+                rec_mat_mul_big(m->tmp, m->res, m->comp, k);
+                rec_mat_free_big(m->res, k);
+                memcpy(m->res, m->tmp, sizeof(m->tmp));
+            }
+        }
+
+        // a(n) = last row of res * (a(k - 1), ..., a(0))
+        result = bignum_new(0);
+        for (size_t j = 0; j < k; j++) {
+            struct list_head *init = bignum_new(fib_rec.init[k - 1 - j]),
+                             *prod = bignum_multiply(m->res[k - 1][j], init),
+                             *sum = bignum_add(result, prod);
+            bignum_free(init);
+            bignum_free(prod);
+            bignum_free(result);
+            result = sum;
+        }
+
+        rec_mat_free_big(m->res, k);
+        rec_mat_free_big(m->comp, k);
+        kfree(m);
+    }
+    uint64_t kt = ktime_sub(ktime_get(), ks);  // measure finish
+    ssize_t ret = (ssize_t) ktime_to_ns(kt);
+
+#ifndef CALC_ONLY
+    // copy result to buffer
+    char *str = bignum_to_string(result);
+    if (!str)
+        ret = -ENOMEM;
+    else if (copy_to_user(buf, str, min(size, strlen(str) + 1)))
+        pr_warn("%s:%d: Cannot copy all content.\n", __func__, __LINE__);
+    kfree(str);
+#endif
+
+    bignum_free(result);
+    return ret;
+}
+
+/* 64 x 64 -> 128 bits product, without relying on __int128 */
+static inline void mul_64x64(uint64_t a, uint64_t b, uint64_t *hi, uint64_t *lo)
+{
+    *hi = mul_u64_u64_shr(a, b, 64);
+    *lo = a * b;
+}
+
+/* res = a * b in 4.124 fixed point, product is truncated */
+static void fixed_mul(uint64_t res[2], const uint64_t a[2], const uint64_t b[2])
+{
+    // 256 bits product w3:w2:w1:w0
+    uint64_t w3, w2, w1, w0, hi, lo, carry;
+    mul_64x64(a[1], b[1], &w1, &w0);
+    mul_64x64(a[0], b[0], &w3, &w2);
+
+    for (int i = 0; i < 2; i++) {
+        mul_64x64(a[i], b[1 - i], &hi, &lo);
+        w1 += lo;
+        carry = w1 < lo;
+        w2 += carry;
+        carry = w2 < carry;
+        w2 += hi;
+        carry += w2 < hi;
+        w3 += carry;
+    }
+
+    res[0] = w3 << 4 | w2 >> 60;
+    res[1] = w2 << 4 | w1 >> 60;
+}
+
+/* floor(r * scale) of a 4.124 fixed point r */
+static uint64_t fixed_scale(const uint64_t r[2], uint64_t scale)
+{
+    uint64_t a1, a0, b1, b0;
+    mul_64x64(r[0], scale, &a1, &a0);
+    mul_64x64(r[1], scale, &b1, &b0);
+    a0 += b1;
+    a1 += a0 < b1;
+    return a1 << 4 | a0 >> 60;
+}
+
+/* 10^frac in 4.124 fixed point of a 0.128 fixed point frac */
+static void exp10_fixed(uint64_t res[2], const uint64_t frac[2])
+{
+    res[0] = 1ULL << 60;
+    res[1] = 0;
+
+    // product of 10^(2^-i) for the top 62 bits
+    for (int i = 0; i < ARRAY_SIZE(exp10_frac); i++)
+        if (frac[0] & (1ULL << (63 - i)))
+            fixed_mul(res, res, exp10_frac[i]);
+
+    // 10^g ~ 1 + g * ln(10) for the remaining g < 2^-62
+    const uint64_t tail[2] = {
+        1ULL << 60, mul_u64_u64_shr(frac[0] & 3, LN10_FIXED, 2) +
+                        mul_u64_u64_shr(frac[1], LN10_FIXED, 66)};
+    fixed_mul(res, res, tail);
+}
+
+static ssize_t fib_leading(uint64_t target, char *buf, size_t size)
+{
+    uint64_t ks = ktime_get();  // measure start
+    uint64_t scale = 1, exp = 0, lead;
+    for (uint64_t i = 1; i < fib_lead_digits; i++)
+        scale *= 10;
+
+    if (target < FIB_TABLE_SIZE) {
+        // exact value is known, just cut its leading digits
+        uint64_t val = fib_table[target], upper = 1;
+        for (; val / upper >= 10; upper *= 10)
+            exp++;
+        if (upper > scale)
+            lead = val / (upper / scale);
+        else
+            lead = val * (scale / upper);
+    } else {
+        // log10(F(n)) = n * log10(phi) - log10(sqrt(5)), psi^n is negligible
+        uint64_t frac[2], hi, lo, sub;
+        mul_64x64(target, log10_phi[2], &frac[1], &lo);
+        mul_64x64(target, log10_phi[1], &hi, &lo);
+        frac[1] += lo;
+        frac[0] = hi + (frac[1] < lo);
+        mul_64x64(target, log10_phi[0], &hi, &lo);
+        frac[0] += lo;
+        exp = hi + (frac[0] < lo);
+
+        // borrow from integer part if fraction part is not enough
+        sub = log10_sqrt5[0] + (frac[1] < log10_sqrt5[1]);
+        frac[1] -= log10_sqrt5[1];
+        exp -= frac[0] < sub;
+        frac[0] -= sub;
+
+        // mantissa in [1, 10) and its error interval
+        uint64_t mant[2], lower[2], upper[2];
+        exp10_fixed(mant, frac);
+        lower[1] = mant[1] - LEAD_ERROR;
+        lower[0] = mant[0] - (mant[1] < LEAD_ERROR);
+        upper[1] = mant[1] + LEAD_ERROR;
+        upper[0] = mant[0] + (upper[1] < LEAD_ERROR);
+
+        // digits are exact only if the whole interval agrees on them
+        lead = fixed_scale(lower, scale);
+        if (lead != fixed_scale(upper, scale))
+            return -ERANGE;
+    }
+    uint64_t kt = ktime_sub(ktime_get(), ks);  // measure finish
+
+#ifndef CALC_ONLY
+    // format as d.ddde<exp>
+    char digits[21], res[48];
+    snprintf(digits, sizeof(digits), "%llu", (unsigned long long) lead);
+    size_t len = snprintf(res, sizeof(res), "%c%s%se%llu", digits[0],
+                          digits[1] ? "." : "", &digits[1],
+                          (unsigned long long) exp);
+    if (copy_to_user(buf, res, min(size, len + 1)))
+        pr_warn("%s:%d: Cannot copy all content.\n", __func__, __LINE__);
+#endif
+
+    return (ssize_t) ktime_to_ns(kt);
+}
+
 static ssize_t fib_basic_big(uint64_t target, char *buf, size_t size)
 {
     uint64_t ks = ktime_get();  // measure start
@@ -100,18 +600,21 @@ static ssize_t fib_basic_big(uint64_t target, char *buf, size_t size)
         swap(lgr, slr);
     }
     uint64_t kt = ktime_sub(ktime_get(), ks);  // measure finish
+    ssize_t ret = (ssize_t) ktime_to_ns(kt);
 
 #ifndef CALC_ONLY
     // copy result to buffer
     char *result = bignum_to_string(slr);
-    if (copy_to_user(buf, result, size))
+    if (!result)
+        ret = -ENOMEM;
+    else if (copy_to_user(buf, result, min(size, strlen(result) + 1)))
         pr_warn("%s:%d: Cannot copy all content.\n", __func__, __LINE__);
-    vfree(result);
+    kfree(result);
 #endif
 
     bignum_free(lgr);
     bignum_free(slr);
-    return (ssize_t) ktime_to_ns(kt);
+    return ret;
 }
 
 static int fib_open(struct inode *inode, struct file *file)
@@ -129,6 +632,19 @@ static int fib_release(struct inode *inode, struct file *file)
     return 0;
 }
 
+/* largest offset that can be seeked to under current mode */
+static loff_t fib_max_length(void)
+{
+    switch (mode) {
+    case FIB_MODE_MOD_64:
+    case FIB_MODE_REC_64:
+    case FIB_MODE_LEADING:
+        return LLONG_MAX;
+    default:
+        return MAX_LENGTH;
+    }
+}
+
 /* calculate the fibonacci number at given offset */
 static ssize_t fib_read(struct file *file,
                         char *buf,
@@ -137,28 +653,55 @@ static ssize_t fib_read(struct file *file,
 {
     ssize_t (*fib_impl)(uint64_t, char *, size_t);
 
+    // offset may be seeked under a mode with larger limit
+    if (*offset > fib_max_length())
+        return -EINVAL;
+
     switch (mode) {
     case FIB_MODE_BASIC_64:
-#ifndef CALC_ONLY
-        pr_info("MODE = BASIC_64.\n");
-#endif
+        pr_debug("MODE = BASIC_64.\n");
         fib_impl = fib_basic_64;
         break;
 
     case FIB_MODE_FAST_DOUBLING_64:
-#ifndef CALC_ONLY
-        pr_info("MODE = FAST_DOUBLING_64.\n");
-#endif
+        pr_debug("MODE = FAST_DOUBLING_64.\n");
         fib_impl = fib_fast_64;
         break;
 
     case FIB_MODE_BASIC_BIG:
-#ifndef CALC_ONLY
-        pr_info("MODE = BASIC_BIG.\n");
-#endif
+        pr_debug("MODE = BASIC_BIG.\n");
         fib_impl = fib_basic_big;
         break;
 
+    case FIB_MODE_MOD_64:
+        if (!fib_modulus) {
+            pr_err("MODULUS NOT SET.\n");
+            return -EINVAL;
+        }
+        pr_debug("MODE = MOD_64.\n");
+        fib_impl = fib_mod_64;
+        break;
+
+    case FIB_MODE_REC_64:
+        pr_debug("MODE = REC_64.\n");
+        fib_impl = fib_rec_64;
+        break;
+
+    case FIB_MODE_REC_BIG:
+        pr_debug("MODE = REC_BIG.\n");
+        fib_impl = fib_rec_big;
+        break;
+
+    case FIB_MODE_TABLE_64:
+        pr_debug("MODE = TABLE_64.\n");
+        fib_impl = fib_table_64;
+        break;
+
+    case FIB_MODE_LEADING:
+        pr_debug("MODE = LEADING.\n");
+        fib_impl = fib_leading;
+        break;
+
     case FIB_MODE_FAST_DOUBLING_BIG:
     default:
 #ifndef CALC_ONLY
@@ -179,51 +722,117 @@ static ssize_t fib_write(struct file *file,
 {
     int val, err = kstrtoint_from_user(buf, size, 10U, &val);
 
-    if (err == ERANGE || err == EINVAL)
+    if (err) {
         pr_err("OVERFLOW OR NOT A NUMBER STRING.\n");
-    else
-        switch (val) {
-        case FIB_MODE_BASIC_64:
-            pr_info("SET MODE : BASIC_64.\n");
-            mode = FIB_MODE_BASIC_64;
-            return FIB_MODE_BASIC_64;
-
-        case FIB_MODE_FAST_DOUBLING_64:
-            pr_info("SET MODE : FAST_64.\n");
-            mode = FIB_MODE_FAST_DOUBLING_64;
-            return FIB_MODE_FAST_DOUBLING_64;
-
-        case FIB_MODE_BASIC_BIG:
-            pr_info("SET MODE : BASIC_BIG.\n");
-            mode = FIB_MODE_BASIC_BIG;
-            return FIB_MODE_BASIC_BIG;
-
-        case FIB_MODE_FAST_DOUBLING_BIG:
-        default:
-            pr_warn("TO BE IMPLEMENTED.\n");
-            break;
-        }
+        return err;
+    }
+
+    switch (val) {
+    case FIB_MODE_BASIC_64:
+        pr_info("SET MODE : BASIC_64.\n");
+        mode = FIB_MODE_BASIC_64;
+        return FIB_MODE_BASIC_64;
+
+    case FIB_MODE_FAST_DOUBLING_64:
+        pr_info("SET MODE : FAST_64.\n");
+        mode = FIB_MODE_FAST_DOUBLING_64;
+        return FIB_MODE_FAST_DOUBLING_64;
+
+    case FIB_MODE_BASIC_BIG:
+        pr_info("SET MODE : BASIC_BIG.\n");
+        mode = FIB_MODE_BASIC_BIG;
+        return FIB_MODE_BASIC_BIG;
+
+    case FIB_MODE_MOD_64:
+        pr_info("SET MODE : MOD_64.\n");
+        mode = FIB_MODE_MOD_64;
+        return FIB_MODE_MOD_64;
+
+    case FIB_MODE_REC_64:
+        pr_info("SET MODE : REC_64.\n");
+        mode = FIB_MODE_REC_64;
+        return FIB_MODE_REC_64;
+
+    case FIB_MODE_REC_BIG:
+        pr_info("SET MODE : REC_BIG.\n");
+        mode = FIB_MODE_REC_BIG;
+        return FIB_MODE_REC_BIG;
+
+    case FIB_MODE_TABLE_64:
+        pr_info("SET MODE : TABLE_64.\n");
+        mode = FIB_MODE_TABLE_64;
+        return FIB_MODE_TABLE_64;
+
+    case FIB_MODE_LEADING:
+        pr_info("SET MODE : LEADING.\n");
+        mode = FIB_MODE_LEADING;
+        return FIB_MODE_LEADING;
+
+    case FIB_MODE_FAST_DOUBLING_BIG:
+    default:
+        pr_warn("TO BE IMPLEMENTED.\n");
+        break;
+    }
 
     return 1;
 }
 
+static long fib_ioctl(struct file *file, unsigned int cmd, unsigned long arg)
+{
+    uint64_t val;
+    struct fib_recurrence rec;
+
+    switch (cmd) {
+    case FIB_IOC_SET_MODULUS:
+        if (get_user(val, (uint64_t __user *) arg))
+            return -EFAULT;
+        if (!val)
+            return -EINVAL;
+        fib_modulus = val;
+        return 0;
+
+    case FIB_IOC_SET_RECURRENCE:
+        if (copy_from_user(&rec, (void __user *) arg, sizeof(rec)))
+            return -EFAULT;
+        if (!rec.order || rec.order > FIB_REC_MAX_ORDER)
+            return -EINVAL;
+        fib_rec = rec;
+        return 0;
+
+    case FIB_IOC_SET_DIGITS:
+        if (get_user(val, (uint64_t __user *) arg))
+            return -EFAULT;
+        if (!val || val > FIB_LEAD_MAX_DIGITS)
+            return -EINVAL;
+        fib_lead_digits = val;
+        return 0;
+
+    default:
+        return -ENOTTY;
+    }
+}
+
 static loff_t fib_device_lseek(struct file *file, loff_t offset, int orig)
 {
-    loff_t new_pos = 0;
+    loff_t new_pos = 0, max_length = fib_max_length();
     switch (orig) {
     case 0: /* SEEK_SET: */
         new_pos = offset;
         break;
     case 1: /* SEEK_CUR: */
-        new_pos = file->f_pos + offset;
+        // f_pos is never negative, so only a positive offset can overflow
+        if (check_add_overflow(file->f_pos, offset, &new_pos))
+            new_pos = max_length;
         break;
     case 2: /* SEEK_END: */
-        new_pos = MAX_LENGTH - offset;
+        // max_length is never negative, so only a negative offset can overflow
+        if (check_sub_overflow(max_length, offset, &new_pos))
+            new_pos = max_length;
         break;
     }
 
-    if (new_pos > MAX_LENGTH)
-        new_pos = MAX_LENGTH;  // max case
+    if (new_pos > max_length)
+        new_pos = max_length;  // max case
     if (new_pos < 0)
         new_pos = 0;        // min case
     file->f_pos = new_pos;  // This is what we'll use now
@@ -234,6 +843,8 @@ const struct file_operations fib_fops = {
     .owner = THIS_MODULE,
     .read = fib_read,
     .write = fib_write,
+    .unlocked_ioctl = fib_ioctl,
+    .compat_ioctl = compat_ptr_ioctl,
     .open = fib_open,
     .release = fib_release,
     .llseek = fib_device_lseek,
@@ -245,6 +856,10 @@ static int __init init_fib_dev(void)
 
     mutex_init(&fib_mutex);
 
+    fib_table[1] = 1;
+    for (int i = 2; i < FIB_TABLE_SIZE; i++)
+        fib_table[i] = fib_table[i - 1] + fib_table[i - 2];
+
     // Let's register the device
     // This will dynamically allocate the major number
     rc = alloc_chrdev_region(&fib_dev, 0, 1, DEV_FIBONACCI_NAME);
@@ -0,0 +1,51 @@
+#if !defined(FIBDRV_H)
+#define FIBDRV_H
+
+#if defined(__KERNEL__)
+#include <linux/ioctl.h>
+#include <linux/types.h>
+#else
+#include <stdint.h>
+#include <sys/ioctl.h>
+#endif  // __KERNEL__
+
+/* modes selected by writing the number as a decimal string */
+enum FIB_MODES {
+    FIB_MODE_BASIC_64 = 0,
+    FIB_MODE_BASIC_BIG = 1,
+    FIB_MODE_FAST_DOUBLING_64 = 2,
+    FIB_MODE_FAST_DOUBLING_BIG = -1,
+    FIB_MODE_MOD_64 = 3,
+    FIB_MODE_REC_64 = 4,
+    FIB_MODE_REC_BIG = 5,
+    FIB_MODE_TABLE_64 = 6,
+    FIB_MODE_LEADING = 7,
+};
+
+#define FIB_IOC_MAGIC 'f'
+#define FIB_REC_MAX_ORDER 8
+#define FIB_LEAD_MAX_DIGITS 15
+
+/*
+ * a(n) = coef[0] * a(n - 1) + ... + coef[order - 1] * a(n - order),
+ * where a(0) ... a(order - 1) are given by init. FIB_MODE_REC_64 works
+ * modulo 2^64, so a negative coefficient may be passed as its two's
+ * complement; FIB_MODE_REC_BIG treats every value as non-negative.
+ */
+struct fib_recurrence {
+    uint64_t order;
+    uint64_t coef[FIB_REC_MAX_ORDER];
+    uint64_t init[FIB_REC_MAX_ORDER];
+};
+
+// set the modulus used by FIB_MODE_MOD_64, must be non-zero
+#define FIB_IOC_SET_MODULUS _IOW(FIB_IOC_MAGIC, 1, uint64_t)
+
+// set the recurrence used by FIB_MODE_REC_64 and FIB_MODE_REC_BIG
+#define FIB_IOC_SET_RECURRENCE _IOW(FIB_IOC_MAGIC, 2, struct fib_recurrence)
+
+// set how many leading digits FIB_MODE_LEADING reports, 1 to 15; reads
+// fail with ERANGE in the rare case the digits cannot be certified
+#define FIB_IOC_SET_DIGITS _IOW(FIB_IOC_MAGIC, 3, uint64_t)
+
+#endif  // FIBDRV_H
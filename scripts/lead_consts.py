@@ -0,0 +1,70 @@
+#!/usr/bin/env python3
+# Print the fixed-point constants of FIB_MODE_LEADING as they appear in
+# fibdrv.c, computed with 150 significant digits.
+
+from decimal import Decimal, getcontext
+
+getcontext().prec = 150
+
+PHI = (1 + Decimal(5).sqrt()) / 2
+LN10 = Decimal(10).ln()
+LOG10_PHI = PHI.ln() / LN10
+LOG10_SQRT5 = Decimal(5).sqrt().ln() / LN10
+TABLE_SIZE = 62
+MASK64 = (1 << 64) - 1
+
+
+def fixed(x, bits):
+    # truncated for the log10 constants, x is in [0, 1)
+    return int(x * (Decimal(2) ** bits))
+
+
+def rounded(x, bits):
+    return int(x * (Decimal(2) ** bits) + Decimal('0.5'))
+
+
+def words(v, n):
+    return [(v >> (64 * i)) & MASK64 for i in reversed(range(n))]
+
+
+def hex64(v):
+    return '0x%016xULL' % v
+
+
+def constants():
+    return {
+        'log10_phi': words(fixed(LOG10_PHI, 192), 3),
+        'log10_sqrt5': words(fixed(LOG10_SQRT5, 128), 2),
+        'ln10': rounded(LN10, 62),
+        'exp10_frac': [
+            words(rounded(Decimal(10)**(Decimal(2)**-(i + 1)), 124), 2)
+            for i in range(TABLE_SIZE)
+        ],
+    }
+
+
+def source():
+    c = constants()
+    phi, sqrt5 = c['log10_phi'], c['log10_sqrt5']
+    lines = [
+        '// log10(phi) in 0.192 and log10(sqrt(5)) in 0.128 fixed point, '
+        'high first',
+        'static const uint64_t log10_phi[3] = {',
+        '    %s};' % ', '.join(hex64(w) for w in phi),
+        'static const uint64_t log10_sqrt5[2] = {%s,' % hex64(sqrt5[0]),
+        '                                        %s};' % hex64(sqrt5[1]),
+        '',
+        '// ln(10) in 2.62 fixed point',
+        '#define LN10_FIXED %s' % hex64(c['ln10']),
+        '',
+        '// 10^(2^-(i + 1)) in 4.124 fixed point, {high, low} 64 bits',
+        'static const uint64_t exp10_frac[%d][2] = {' % TABLE_SIZE,
+    ]
+    lines += ['    {%s, %s},' % (hex64(hi), hex64(lo))
+              for hi, lo in c['exp10_frac']]
+    lines.append('};')
+    return '\n'.join(lines) + '\n'
+
+
+if __name__ == '__main__':
+    print(source(), end='')
@@ -1,5 +1,14 @@
 #!/usr/bin/env python3
 
+import sys
+from decimal import Decimal, ROUND_FLOOR
+
+sys.dont_write_bytecode = True
+import lead_consts  # noqa: E402
+
+if hasattr(sys, 'set_int_max_str_digits'):
+    sys.set_int_max_str_digits(0)
+
 expect = [0, 1]
 result = []
 result_split = []
@@ -26,3 +35,85 @@ for i in dics:
         print('input: %s' %(fib))
         print('expected: %s' %(expect[i[0]]))
         exit()
+
+
+def fib_pair(n, m=None):
+    # (F(n), F(n + 1)) by fast doubling, modulo m if given
+    a, b = 0, 1
+    for bit in bin(n)[2:]:
+        a, b = a * (2 * b - a), a * a + b * b
+        if bit == '1':
+            a, b = b, a + b
+        if m:
+            a, b = a % m, b % m
+    return a, b
+
+
+# (coef, init) as set by client.c
+recurrences = {
+    'lucas': ([1, 1], [2, 1]),
+    'pell': ([2, 1], [0, 1]),
+    'tribonacci': ([1, 1, 1], [0, 0, 1]),
+    'padovan': ([0, 1, 1], [1, 1, 1]),
+    'period6': ([1, -1], [0, 1]),
+}
+
+
+def mat_mul(a, b, m):
+    return [[sum(x * y for x, y in zip(row, col)) % m if m else
+             sum(x * y for x, y in zip(row, col)) for col in zip(*b)]
+            for row in a]
+
+
+def recurrence(name, n, m=None):
+    # a(n) by power of the companion matrix, modulo m if given
+    coef, init = recurrences[name]
+    k = len(coef)
+    if n < k:
+        return init[n] % m if m else init[n]
+    comp = [coef] + [[int(i == j) for j in range(k)] for i in range(k - 1)]
+    res = [[int(i == j) for j in range(k)] for i in range(k)]
+    for bit in bin(n - k + 1)[2:]:
+        res = mat_mul(res, res, m)
+        if bit == '1':
+            res = mat_mul(res, comp, m)
+    a = sum(res[0][j] * init[k - 1 - j] for j in range(k))
+    return a % m if m else a
+
+
+def leading(n, k):
+    # first k digits of F(n), from F(n) itself while it is cheap to compute
+    if n <= 1000000:
+        s = str(fib_pair(n)[0])
+        if s == '0':
+            return '0e0'
+        exp = len(s) - 1
+        s = (s + '0' * k)[:k]
+    else:
+        x = n * lead_consts.LOG10_PHI - lead_consts.LOG10_SQRT5
+        exp = int(x.to_integral_value(ROUND_FLOOR))
+        s = str(int(Decimal(10)**(x - exp + k - 1)))
+    return s[0] + ('.' + s[1:] if k > 1 else '') + 'e' + str(exp)
+
+
+checks = {
+    'mod': lambda arg, n: str(fib_pair(n, int(arg))[0]),
+    'rec64': lambda arg, n: str(recurrence(arg, n, 1 << 64)),
+    'recbig': lambda arg, n: str(recurrence(arg, n)),
+    'table': lambda arg, n: str(fib_pair(n, 1 << 64)[0]),
+    'basic64': lambda arg, n: str(fib_pair(n, 1 << 64)[0]),
+    'lead': lambda arg, n: leading(n, int(arg)),
+}
+
+for r in result:
+    if (r.find('Checking') != -1):
+        words = r.split(' ')
+        k = int(words[4].split(',')[0])
+        got = r.split('returned the sequence ')[1].rstrip('\n')[:-1]
+        name, _, arg = words[1].partition('=')
+        want = checks[name](arg, k)
+        if (want != got):
+            print('%s f(%s) fail' % (words[1], str(k)))
+            print('input: %s' % (got))
+            print('expected: %s' % (want))
+            exit(1)
@@ -0,0 +1,118 @@
+#!/usr/bin/env python3
+# Re-verify FIB_MODE_LEADING without loading the module: check that the
+# constants in fibdrv.c match scripts/lead_consts.py, replay the fixed-point
+# evaluation of fib_leading() bit for bit, and compare it against exact F(n)
+# and 150-digit decimal references. Also check that the measured mantissa
+# error stays below LEAD_ERROR.
+
+import os
+import random
+import re
+import sys
+from decimal import Decimal, ROUND_FLOOR
+
+sys.dont_write_bytecode = True
+import lead_consts  # noqa: E402
+
+ROOT = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..')
+MASK64 = (1 << 64) - 1
+MASK128 = (1 << 128) - 1
+ONE = 1 << 124
+TABLE_SIZE = 94
+MAX_DIGITS = 15
+
+if hasattr(sys, 'set_int_max_str_digits'):
+    sys.set_int_max_str_digits(0)
+
+with open(os.path.join(ROOT, 'fibdrv.c'), 'r') as f:
+    source = f.read()
+if lead_consts.source() not in source:
+    print('constants in fibdrv.c differ from scripts/lead_consts.py')
+    exit(1)
+LEAD_ERROR = 1 << int(re.search(r'#define LEAD_ERROR \(1ULL << (\d+)\)',
+                                source).group(1))
+
+c = lead_consts.constants()
+L = c['log10_phi'][0] << 128 | c['log10_phi'][1] << 64 | c['log10_phi'][2]
+S = c['log10_sqrt5'][0] << 64 | c['log10_sqrt5'][1]
+T = [hi << 64 | lo for hi, lo in c['exp10_frac']]
+
+
+def exp10_fixed(frac):
+    res = ONE
+    for i in range(len(T)):
+        if frac >> (127 - i) & 1:
+            res = (res * T[i]) >> 124 & MASK128
+    term = ((((frac >> 64) & 3) * c['ln10']) >> 2 & MASK64) + \
+        ((frac & MASK64) * c['ln10'] >> 66 & MASK64)
+    return (res * (ONE + (term & MASK64))) >> 124 & MASK128
+
+
+def fib_leading(n, digits):
+    # same steps as fib_leading() for n >= FIB_TABLE_SIZE
+    v = ((n * L) >> 64) - S
+    exp, frac = v >> 128, v & MASK128
+    mant = exp10_fixed(frac)
+    scale = 10**(digits - 1)
+    lead = ((mant - LEAD_ERROR) * scale) >> 124
+    if lead != ((mant + LEAD_ERROR) * scale) >> 124:
+        return None, mant
+    return fmt(str(lead), exp), mant
+
+
+def fmt(d, exp):
+    return d[0] + ('.' + d[1:] if len(d) > 1 else '') + 'e' + str(exp)
+
+
+def fib(n):
+    a, b = 0, 1
+    for bit in bin(n)[2:]:
+        a, b = a * (2 * b - a), a * a + b * b
+        if bit == '1':
+            a, b = b, a + b
+    return a
+
+
+LOG10_PHI, LOG10_SQRT5 = lead_consts.LOG10_PHI, lead_consts.LOG10_SQRT5
+
+
+def mantissa(n):
+    x = n * LOG10_PHI - LOG10_SQRT5
+    exp = int(x.to_integral_value(ROUND_FLOOR))
+    return Decimal(10)**(x - exp), exp
+
+
+random.seed(0)
+exact = list(range(TABLE_SIZE, 2000)) + [384339] + \
+    [random.randint(2000, 200000) for _ in range(100)]
+approx = [(1 << 63) - 1, 1038753276079106978] + \
+    [random.getrandbits(random.randint(12, 63)) for _ in range(3000)]
+
+failed, erange, max_err = 0, 0, 0
+for n in exact + approx:
+    if n in exact:
+        s = str(fib(n))
+        expect = [fmt(s[:k], len(s) - 1) for k in range(1, MAX_DIGITS + 1)]
+        m = Decimal(s[:60]) / Decimal(10)**(len(s[:60]) - 1)
+    else:
+        m, exp = mantissa(n)
+        expect = [
+            fmt(str(int((m * 10**(k - 1)).to_integral_value(ROUND_FLOOR))),
+                exp) for k in range(1, MAX_DIGITS + 1)
+        ]
+    for k in range(1, MAX_DIGITS + 1):
+        res, mant = fib_leading(n, k)
+        if res is None:
+            erange += 1
+        elif res != expect[k - 1]:
+            failed += 1
+            print('F(%d) k=%d fail' % (n, k))
+            print('input: %s' % res)
+            print('expected: %s' % expect[k - 1])
+    max_err = max(max_err, abs(Decimal(mant) - m * ONE))
+
+print('%d cases, %d mismatches, %d ERANGE, max mantissa error %.1f of %d' %
+      ((len(exact) + len(approx)) * MAX_DIGITS, failed, erange, max_err,
+       LEAD_ERROR))
+if failed or max_err >= LEAD_ERROR:
+    exit(1)